@@ -17,6 +17,12 @@ int DisplayInitialize(void);
 /** Free all display resources. */
 void DisplayUninitialize(void);
 
+/** Get the refresh rate of the display showing the emulator window.
+ * @return 0 if the refresh rate is unknown,
+ * @return the refresh rate in Hz on success.
+ */
+int DisplayGetRefreshRate(void);
+
 /** Draw a specific sprite on the display.
  * @param X Drawing X coordinate.
  * @param Y Drawing Y coordinate.
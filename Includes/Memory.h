@@ -16,10 +16,28 @@
 /** Where to load programs and to start them. */
 #define MEMORY_RAM_PROGRAM_ENTRY_POINT 512
 
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** A function called each time the RAM content is modified.
+ * @param Address The first modified byte address.
+ * @param Size How many bytes were modified.
+ */
+typedef void (*TMemoryRAMWriteCallback)(int Address, int Size);
+
 //-------------------------------------------------------------------------------------------------
 // Functions
 //-------------------------------------------------------------------------------------------------
+/** Push a return address on the top of the stack.
+ * @param Address The address to push.
+ * @note The program is aborted if the stack is full.
+ */
 void MemoryStackPush(unsigned short Address);
+
+/** Remove the address located on the top of the stack.
+ * @return The popped address.
+ * @note The program is aborted if the stack is empty.
+ */
 unsigned short MemoryStackPop(void);
 
 /** Load the full RAM content from a file.
@@ -35,6 +53,11 @@ int MemoryRAMLoadFromFile(char *Pointer_String_File_Name);
  * @return The read data.
  */
 unsigned char MemoryRAMReadByte(int Address);
+
+/** Write 8-bit data to the RAM.
+ * @param Address The byte to write address.
+ * @param Data The data to write.
+ */
 void MemoryRAMWriteByte(int Address, unsigned char Data);
 
 /** Read 16-bit data from the RAM and convert them to the emulator platform endianness.
@@ -43,6 +66,15 @@ void MemoryRAMWriteByte(int Address, unsigned char Data);
  */
 unsigned short MemoryRAMReadWord(int Address);
 
+/** Convert 16-bit data from the emulator platform endianness to Chip-8 big endian and write them to the RAM.
+ * @param Address The word to write address. Address will automatically be 16-bit aligned.
+ * @param Data The data to write.
+ */
 void MemoryRAMWriteWord(int Address, unsigned short Data);
 
+/** Register the function to call each time the RAM content is modified, by a program load or by a write access.
+ * @param Pointer_Callback The function to call, or NULL to stop notifying RAM modifications. Only one function can be registered at a time.
+ */
+void MemoryRAMSetWriteCallback(TMemoryRAMWriteCallback Pointer_Callback);
+
 #endif
@@ -5,10 +5,43 @@
 #ifndef H_PROCESSOR_H
 #define H_PROCESSOR_H
 
+//-------------------------------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------------------------------
+/** All instruction sequences the processor can execute at once. */
+typedef enum
+{
+	PROCESSOR_FUSION_LOAD_I_DRAW, //!< LD I, addr followed by DRW Vx, Vy, nibble.
+	PROCESSOR_FUSION_LOAD_REGISTERS, //!< Several consecutive LD Vx, byte.
+	PROCESSOR_FUSION_COUNTED_LOOP, //!< ADD Vx, byte followed by SE Vy, byte or SNE Vy, byte, followed by JP addr.
+	PROCESSOR_FUSIONS_COUNT
+} TProcessorFusion;
+
 //-------------------------------------------------------------------------------------------------
 // Functions
 //-------------------------------------------------------------------------------------------------
-/** Execute the instruction pointed by Program Counter register and update RAM, stack and registers accordingly. */
-void ProcessorExecuteNextInstruction(void);
+/** Execute the instruction pointed by Program Counter register and update RAM, stack and registers accordingly.
+ * @return How many Chip-8 instructions were executed (a common instruction sequence starting at Program Counter address is executed at once).
+ */
+int ProcessorExecuteNextInstruction(void);
+
+/** Forget the fused instruction sequences containing a RAM area, they will be analyzed again on their next execution.
+ * @param Address The modified area first address.
+ * @param Size The modified area size in bytes.
+ * @note This function must be called each time the RAM is written, register it with MemoryRAMSetWriteCallback().
+ */
+void ProcessorInvalidateFusedSequences(int Address, int Size);
+
+/** Tell how many times an instruction sequence was executed at once.
+ * @param Fusion The instruction sequence kind.
+ * @return The sequence executions count.
+ */
+unsigned long long ProcessorGetFusionExecutionsCount(TProcessorFusion Fusion);
+
+/** Get a fused instruction sequence kind name suitable for statistics reports.
+ * @param Fusion The instruction sequence kind.
+ * @return The sequence name.
+ */
+char *ProcessorGetFusionName(TProcessorFusion Fusion);
 
 #endif
@@ -0,0 +1,67 @@
+/** @file Profiler.h
+ * Optional guest-level profiler counting executed instructions and tracking Chip-8 subroutine calls.
+ * @note The profiler is compiled only when PROFILER_ENABLED is defined (see the "profile" makefile target), otherwise the hooks expand to nothing.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_PROFILER_H
+#define H_PROFILER_H
+
+//-------------------------------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------------------------------
+/** @def PROFILER_RECORD_INSTRUCTION() Account for an instruction that is going to be executed.
+ * @param Address The instruction address.
+ * @param Instruction The instruction code.
+ */
+/** @def PROFILER_ENTER_SUBROUTINE() Push a subroutine on the profiler shadow call stack (must be called each time a CALL instruction is executed).
+ * @param Address The subroutine address.
+ */
+/** @def PROFILER_LEAVE_SUBROUTINE() Pop the current subroutine from the profiler shadow call stack (must be called each time a RET instruction is executed). */
+#ifdef PROFILER_ENABLED
+	#define PROFILER_RECORD_INSTRUCTION(Address, Instruction) ProfilerRecordInstruction(Address, Instruction)
+	#define PROFILER_ENTER_SUBROUTINE(Address) ProfilerEnterSubroutine(Address)
+	#define PROFILER_LEAVE_SUBROUTINE() ProfilerLeaveSubroutine()
+#else
+	#define PROFILER_RECORD_INSTRUCTION(Address, Instruction) {} // Use an empty scope for the same reason than LOG_DEBUG()
+	#define PROFILER_ENTER_SUBROUTINE(Address) {}
+	#define PROFILER_LEAVE_SUBROUTINE() {}
+#endif
+
+#ifdef PROFILER_ENABLED
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Increment the execution counters of an instruction and of its opcode class, then assign a sample to the current call stack.
+ * @param Address The instruction address.
+ * @param Instruction The instruction code.
+ * @note Use PROFILER_RECORD_INSTRUCTION() instead of calling this function directly.
+ */
+void ProfilerRecordInstruction(int Address, unsigned short Instruction);
+
+/** Add a subroutine to the shadow call stack.
+ * @param Address The called subroutine address.
+ * @note Use PROFILER_ENTER_SUBROUTINE() instead of calling this function directly.
+ */
+void ProfilerEnterSubroutine(int Address);
+
+/** Return to the caller of the current subroutine in the shadow call stack.
+ * @note Use PROFILER_LEAVE_SUBROUTINE() instead of calling this function directly.
+ */
+void ProfilerLeaveSubroutine(void);
+
+/** Write the collected call stacks in the "folded" format understood by flame graph tools (one "frame;frame;frame count" line per call stack).
+ * @param Pointer_String_File_Name The file to create.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+int ProfilerSaveFoldedStacks(char *Pointer_String_File_Name);
+
+/** Write a disassembly listing of all executed instructions annotated with their execution count, preceded by the per opcode class counters. Each address shows the last instruction code executed there.
+ * @param Pointer_String_File_Name The file to create.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+int ProfilerSaveAnnotatedDisassembly(char *Pointer_String_File_Name);
+#endif
+
+#endif
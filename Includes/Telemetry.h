@@ -0,0 +1,52 @@
+/** @file Telemetry.h
+ * Gather host performance counters (emulation speed, frame pacing, rendering latency) and publish them.
+ * Counters are periodically written to the file named by the CHIP8_EMULATOR_STATS_FILE environment variable, and are served as text to any client connecting to the UNIX socket named by the CHIP8_EMULATOR_STATS_SOCKET environment variable. Each publication method is disabled when its environment variable is not set.
+ * @author Adrien RICCIARDI
+ */
+#ifndef H_TELEMETRY_H
+#define H_TELEMETRY_H
+
+#include <SDL2/SDL.h>
+
+//-------------------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------------------
+/** Start the thread computing rates and publishing the counters.
+ * @note The display must be initialized, as its refresh rate is needed to detect dropped frames.
+ * @return -1 if an error occurred,
+ * @return 0 on success.
+ */
+int TelemetryInitialize(void);
+
+/** Remove the statistics socket file if it was created. The socket itself is closed on process termination. */
+void TelemetryUninitialize(void);
+
+/** Account for instructions executed by a single Chip-8 processor dispatch.
+ * @param Count How many instructions were executed.
+ */
+void TelemetryAddExecutedInstructions(int Count);
+
+/** Account for time the processor thread spent waiting instead of executing instructions.
+ * @param Duration The waiting duration, in SDL performance counter ticks.
+ */
+void TelemetryAddProcessorStallTime(Uint64 Duration);
+
+/** Account for a rendered frame. The frame is considered as dropped if it lasted noticeably longer than the display refresh period.
+ * @param Duration Time elapsed since the previous frame, in SDL performance counter ticks.
+ */
+void TelemetryRecordFrame(Uint64 Duration);
+
+/** Account for the time taken by a SDL_RenderPresent() call.
+ * @param Duration SDL_RenderPresent() execution time, in SDL performance counter ticks.
+ */
+void TelemetryRecordPresentLatency(Uint64 Duration);
+
+/** Show or hide the statistics overlay in the emulator window. */
+void TelemetryToggleOverlay(void);
+
+/** Draw the statistics overlay on top of the current frame if the overlay is enabled.
+ * @param Pointer_Renderer The renderer the frame is drawn with.
+ */
+void TelemetryDrawOverlay(SDL_Renderer *Pointer_Renderer);
+
+#endif
@@ -8,6 +8,7 @@
 #include <Memory.h>
 #include <SDL2/SDL.h>
 #include <stdlib.h>
+#include <Telemetry.h>
 
 //-------------------------------------------------------------------------------------------------
 // Private constants
@@ -65,6 +66,27 @@ void DisplayUninitialize(void)
 	SDL_DestroyWindow(Pointer_Display_Window);
 }
 
+int DisplayGetRefreshRate(void)
+{
+	int Display_Index;
+	SDL_DisplayMode Display_Mode;
+	
+	// Find the display the window is on
+	Display_Index = SDL_GetWindowDisplayIndex(Pointer_Display_Window);
+	if (Display_Index < 0)
+	{
+		LOG_ERROR("Failed to get the window display index (%s).", SDL_GetError());
+		return 0;
+	}
+	
+	if (SDL_GetCurrentDisplayMode(Display_Index, &Display_Mode) != 0)
+	{
+		LOG_ERROR("Failed to get display %d mode (%s).", Display_Index, SDL_GetError());
+		return 0;
+	}
+	return Display_Mode.refresh_rate; // SDL reports 0 when the refresh rate is unknown
+}
+
 int DisplayDrawSprite(int X, int Y, int RAM_Address, int Size)
 {
 	unsigned char Byte, Is_Pixel_Currently_Set;
@@ -111,6 +133,7 @@ void DisplayUpdate(void)
 {
 	int Coordinate_Y, Coordinate_X;
 	SDL_Rect Rectangle;
+	Uint64 Present_Start_Timestamp;
 	
 	// Clear the display with a blue background (like white-on-blue LCD modules)
 	if (SDL_SetRenderDrawColor(Pointer_Display_Main_Renderer, 0, 0, 200, 255) != 0)
@@ -150,6 +173,11 @@ void DisplayUpdate(void)
 		}
 	}
 	
+	// Add performance statistics on top of the Chip-8 display if requested
+	TelemetryDrawOverlay(Pointer_Display_Main_Renderer);
+	
 	// Update screen
+	Present_Start_Timestamp = SDL_GetPerformanceCounter();
 	SDL_RenderPresent(Pointer_Display_Main_Renderer);
+	TelemetryRecordPresentLatency(SDL_GetPerformanceCounter() - Present_Start_Timestamp);
 }
@@ -6,11 +6,23 @@
 #include <Log.h>
 #include <Memory.h>
 #include <Processor.h>
+#include <Profiler.h>
 #include <SDL2/SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <Telemetry.h>
 #include <time.h>
 
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+#ifdef PROFILER_ENABLED
+	/** Where to store the profiler call stacks, ready to be fed to a flame graph generator. */
+	#define MAIN_PROFILER_FOLDED_STACKS_FILE_NAME "chip8-emulator-profile.folded"
+	/** Where to store the profiler annotated disassembly. */
+	#define MAIN_PROFILER_ANNOTATED_DISASSEMBLY_FILE_NAME "chip8-emulator-profile.lst"
+#endif
+
 //-------------------------------------------------------------------------------------------------
 // Private variables
 //-------------------------------------------------------------------------------------------------
@@ -27,6 +39,13 @@ static void MainExitUninitializeSDL(void)
 	LOG_DEBUG("SDL has been uninitialized.");
 }
 
+/** Remove telemetry resources on program exit. */
+static void MainExitUninitializeTelemetry(void)
+{
+	TelemetryUninitialize();
+	LOG_DEBUG("Telemetry has been uninitialized.");
+}
+
 /** Close display resources on program exit. */
 static void MainExitUninitializeDisplay(void)
 {
@@ -34,6 +53,15 @@ static void MainExitUninitializeDisplay(void)
 	LOG_DEBUG("Display has been uninitialized.");
 }
 
+#ifdef PROFILER_ENABLED
+/** Dump profiling results to files on program exit. */
+static void MainExitSaveProfile(void)
+{
+	if (ProfilerSaveFoldedStacks(MAIN_PROFILER_FOLDED_STACKS_FILE_NAME) == 0) LOG_DEBUG("Profiler call stacks have been saved to '%s'.", MAIN_PROFILER_FOLDED_STACKS_FILE_NAME);
+	if (ProfilerSaveAnnotatedDisassembly(MAIN_PROFILER_ANNOTATED_DISASSEMBLY_FILE_NAME) == 0) LOG_DEBUG("Profiler annotated disassembly has been saved to '%s'.", MAIN_PROFILER_ANNOTATED_DISASSEMBLY_FILE_NAME);
+}
+#endif
+
 // TODO
 /*static void MainExitUninitializeProcessorThread(void)
 {
@@ -46,12 +74,16 @@ static void MainExitUninitializeDisplay(void)
  */
 static int MainThreadProcessor(void __attribute__((unused)) *Pointer)
 {
+	Uint64 Stall_Start_Timestamp;
+	
 	while (1)
 	{
-		ProcessorExecuteNextInstruction();
+		TelemetryAddExecutedInstructions(ProcessorExecuteNextInstruction());
 		
 		// TEST
+		Stall_Start_Timestamp = SDL_GetPerformanceCounter();
 		getchar();
+		TelemetryAddProcessorStallTime(SDL_GetPerformanceCounter() - Stall_Start_Timestamp);
 	}
 	
 	// To make the compiler happy
@@ -64,6 +96,7 @@ static int MainThreadProcessor(void __attribute__((unused)) *Pointer)
 int main(int argc, char *argv[])
 {
 	SDL_Event Event;
+	Uint64 Previous_Frame_Timestamp, Current_Frame_Timestamp;
 	
 	// Check parameters
 	if (argc != 2)
@@ -72,6 +105,9 @@ int main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 	
+	// Make sure the processor never executes outdated instructions
+	MemoryRAMSetWriteCallback(ProcessorInvalidateFusedSequences);
+	
 	// Load the requested program
 	if (MemoryRAMLoadFromFile(argv[1]) != 0) return EXIT_FAILURE;
 	
@@ -89,6 +125,14 @@ int main(int argc, char *argv[])
 	if (DisplayInitialize() != 0) return EXIT_FAILURE;
 	atexit(MainExitUninitializeDisplay);
 	
+	// Start collecting and publishing performance counters
+	if (TelemetryInitialize() != 0) return EXIT_FAILURE;
+	atexit(MainExitUninitializeTelemetry);
+	
+#ifdef PROFILER_ENABLED
+	atexit(MainExitSaveProfile);
+#endif
+	
 	// Execute the Chip-8 program in a separated thread to handle SDL events using the main thread
 	if (SDL_CreateThread(MainThreadProcessor, "Chip-8 CPU", NULL) == NULL)
 	{
@@ -96,6 +140,7 @@ int main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 	
+	Previous_Frame_Timestamp = SDL_GetPerformanceCounter();
 	while (1)
 	{
 		// Handle SDL events
@@ -107,12 +152,22 @@ int main(int argc, char *argv[])
 					LOG_DEBUG("Received quit event.");
 					return EXIT_SUCCESS;
 					
+				case SDL_KEYDOWN:
+					// Show or hide performance statistics
+					if ((Event.key.keysym.sym == SDLK_F1) && !Event.key.repeat) TelemetryToggleOverlay();
+					break;
+					
 				default:
 					break;
 			}
 		}
 		
 		DisplayUpdate();
+		
+		// Measure the time elapsed since the previous frame
+		Current_Frame_Timestamp = SDL_GetPerformanceCounter();
+		TelemetryRecordFrame(Current_Frame_Timestamp - Previous_Frame_Timestamp);
+		Previous_Frame_Timestamp = Current_Frame_Timestamp;
 	}
 	
 	return EXIT_SUCCESS;
@@ -8,6 +8,7 @@
 #include <fcntl.h>
 #include <Log.h>
 #include <Memory.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -22,12 +23,45 @@ static unsigned char Memory_RAM[MEMORY_RAM_TOTAL_SIZE];
 /** 16-bit access to RAM. */
 static unsigned short *Pointer_Memory_RAM_Word = (unsigned short *) Memory_RAM;
 
+/** The stack holding subroutines return addresses. */
+static unsigned short Memory_Stack[MEMORY_STACK_TOTAL_SIZE];
+/** Index of the next free stack slot. */
+static int Memory_Stack_Pointer = 0;
+
+/** The function to notify when the RAM content is modified, or NULL if nobody needs to be notified. */
+static TMemoryRAMWriteCallback Pointer_Memory_RAM_Write_Callback = NULL;
+
 //-------------------------------------------------------------------------------------------------
 // Public functions
 //-------------------------------------------------------------------------------------------------
+void MemoryStackPush(unsigned short Address)
+{
+	if (Memory_Stack_Pointer >= MEMORY_STACK_TOTAL_SIZE)
+	{
+		LOG_ERROR("Error : stack overflow when pushing address 0x%04X, aborting program.", Address);
+		exit(EXIT_FAILURE);
+	}
+	
+	Memory_Stack[Memory_Stack_Pointer] = Address;
+	Memory_Stack_Pointer++;
+}
+
+unsigned short MemoryStackPop(void)
+{
+	if (Memory_Stack_Pointer <= 0)
+	{
+		LOG_ERROR("Error : stack underflow, aborting program.");
+		exit(EXIT_FAILURE);
+	}
+	
+	Memory_Stack_Pointer--;
+	return Memory_Stack[Memory_Stack_Pointer];
+}
+
 int MemoryRAMLoadFromFile(char *Pointer_String_File_Name)
 {
 	int File_Descriptor;
+	ssize_t Read_Bytes_Count;
 	
 	// Try to open the file
 	LOG_DEBUG("Opening file '%s'...", Pointer_String_File_Name);
@@ -40,7 +74,8 @@ int MemoryRAMLoadFromFile(char *Pointer_String_File_Name)
 	
 	// Load the file content
 	LOG_DEBUG("Loading file content...");
-	if (read(File_Descriptor, Memory_RAM + MEMORY_RAM_PROGRAM_ENTRY_POINT, MEMORY_RAM_TOTAL_SIZE - MEMORY_RAM_PROGRAM_ENTRY_POINT) <= 0)
+	Read_Bytes_Count = read(File_Descriptor, Memory_RAM + MEMORY_RAM_PROGRAM_ENTRY_POINT, MEMORY_RAM_TOTAL_SIZE - MEMORY_RAM_PROGRAM_ENTRY_POINT);
+	if (Read_Bytes_Count <= 0)
 	{
 		LOG_ERROR("Could not read file (%s).", strerror(errno));
 		close(File_Descriptor);
@@ -49,6 +84,7 @@ int MemoryRAMLoadFromFile(char *Pointer_String_File_Name)
 	
 	LOG_DEBUG("File successfully loaded.");
 	close(File_Descriptor);
+	if (Pointer_Memory_RAM_Write_Callback != NULL) Pointer_Memory_RAM_Write_Callback(MEMORY_RAM_PROGRAM_ENTRY_POINT, Read_Bytes_Count);
 	return 0;
 }
 
@@ -59,6 +95,14 @@ unsigned char MemoryRAMReadByte(int Address)
 	return Memory_RAM[Address];
 }
 
+void MemoryRAMWriteByte(int Address, unsigned char Data)
+{
+	assert(Address < MEMORY_RAM_TOTAL_SIZE);
+	
+	Memory_RAM[Address] = Data;
+	if (Pointer_Memory_RAM_Write_Callback != NULL) Pointer_Memory_RAM_Write_Callback(Address, 1);
+}
+
 unsigned short MemoryRAMReadWord(int Address)
 {
 	assert(Address < MEMORY_RAM_TOTAL_SIZE);
@@ -69,3 +113,20 @@ unsigned short MemoryRAMReadWord(int Address)
 	// Convert read data from Chip-8 big endian to platform endianness
 	return ntohs(Pointer_Memory_RAM_Word[Address]);
 }
+
+void MemoryRAMWriteWord(int Address, unsigned short Data)
+{
+	assert(Address < MEMORY_RAM_TOTAL_SIZE);
+	
+	// Divide address by 2 as we access two bytes at a time
+	Address >>= 1;
+	
+	// Convert data from platform endianness to Chip-8 big endian
+	Pointer_Memory_RAM_Word[Address] = htons(Data);
+	if (Pointer_Memory_RAM_Write_Callback != NULL) Pointer_Memory_RAM_Write_Callback(Address * 2, 2);
+}
+
+void MemoryRAMSetWriteCallback(TMemoryRAMWriteCallback Pointer_Callback)
+{
+	Pointer_Memory_RAM_Write_Callback = Pointer_Callback;
+}
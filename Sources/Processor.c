@@ -6,6 +6,8 @@
 #include <Log.h>
 #include <Memory.h>
 #include <Processor.h>
+#include <Profiler.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <unistd.h>
 
@@ -15,6 +17,22 @@
 /** All available Vk registers. */
 #define PROCESSOR_VK_REGISTERS_COUNT 16
 
+/** Maximum amount of instructions a fused instruction sequence can contain. */
+#define PROCESSOR_FUSED_SEQUENCE_MAXIMUM_INSTRUCTIONS_COUNT 8
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** Cache the analysis of the instruction sequence starting at a given address. */
+typedef struct
+{
+	unsigned char Is_Analyzed; //!< Set to 0 when the sequence must be analyzed on its next execution.
+	unsigned char Is_Fused; //!< Set to 1 when the sequence can be executed at once.
+	TProcessorFusion Fusion; //!< The sequence kind.
+	int Instructions_Count; //!< How many instructions the sequence contains.
+	unsigned short Instructions[PROCESSOR_FUSED_SEQUENCE_MAXIMUM_INSTRUCTIONS_COUNT]; //!< The sequence instructions, already converted to platform endianness.
+} TProcessorFusedSequence;
+
 //-------------------------------------------------------------------------------------------------
 // Private variables
 //-------------------------------------------------------------------------------------------------
@@ -27,17 +45,150 @@ static unsigned short Processor_Register_I;
 /** All Vk registers. */
 static unsigned char Processor_Registers_Vk[PROCESSOR_VK_REGISTERS_COUNT];
 
+/** The instruction sequence starting at each RAM address. */
+static TProcessorFusedSequence Processor_Fused_Sequences[MEMORY_RAM_TOTAL_SIZE];
+
+/** How many times each fused instruction sequence kind was executed (relaxed atomics as the counters are read by the telemetry thread). */
+static atomic_ullong Processor_Fusion_Executions_Counts[PROCESSOR_FUSIONS_COUNT];
+
+/** Fused instruction sequence kinds names. */
+static char *Pointer_String_Processor_Fusion_Names[PROCESSOR_FUSIONS_COUNT] =
+{
+	"load_i_draw",
+	"load_registers",
+	"counted_loop"
+};
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Find whether the instructions starting at the provided address form a sequence that can be executed at once, and cache the result.
+ * @param Address The sequence first instruction address.
+ */
+static void ProcessorAnalyzeInstructionSequence(int Address)
+{
+	TProcessorFusedSequence *Pointer_Sequence = &Processor_Fused_Sequences[Address];
+	unsigned short Instructions[PROCESSOR_FUSED_SEQUENCE_MAXIMUM_INSTRUCTIONS_COUNT];
+	int Available_Instructions_Count, Instructions_Count = 0, i;
+	
+	Pointer_Sequence->Is_Analyzed = 1;
+	Pointer_Sequence->Is_Fused = 0;
+	
+	// Fetch as many instructions as a sequence can contain without crossing RAM end
+	for (Available_Instructions_Count = 0; Available_Instructions_Count < PROCESSOR_FUSED_SEQUENCE_MAXIMUM_INSTRUCTIONS_COUNT; Available_Instructions_Count++)
+	{
+		if (Address + Available_Instructions_Count * 2 + 1 >= MEMORY_RAM_TOTAL_SIZE) break;
+		Instructions[Available_Instructions_Count] = MemoryRAMReadWord(Address + Available_Instructions_Count * 2);
+	}
+	if (Available_Instructions_Count < 2) return;
+	
+	// LD I, addr ; DRW Vx, Vy, nibble
+	if (((Instructions[0] >> 12) == 0xA) && ((Instructions[1] >> 12) == 0xD))
+	{
+		Pointer_Sequence->Fusion = PROCESSOR_FUSION_LOAD_I_DRAW;
+		Instructions_Count = 2;
+	}
+	// ADD Vx, byte ; SE Vy, byte or SNE Vy, byte ; JP addr
+	else if ((Available_Instructions_Count >= 3) && ((Instructions[0] >> 12) == 7) && (((Instructions[1] >> 12) == 3) || ((Instructions[1] >> 12) == 4)) && ((Instructions[2] >> 12) == 1))
+	{
+		Pointer_Sequence->Fusion = PROCESSOR_FUSION_COUNTED_LOOP;
+		Instructions_Count = 3;
+	}
+	// LD Vx, byte ; LD Vx, byte ; ...
+	else
+	{
+		while ((Instructions_Count < Available_Instructions_Count) && ((Instructions[Instructions_Count] >> 12) == 6)) Instructions_Count++;
+		if (Instructions_Count < 2) return;
+		Pointer_Sequence->Fusion = PROCESSOR_FUSION_LOAD_REGISTERS;
+	}
+	
+	for (i = 0; i < Instructions_Count; i++) Pointer_Sequence->Instructions[i] = Instructions[i];
+	Pointer_Sequence->Instructions_Count = Instructions_Count;
+	Pointer_Sequence->Is_Fused = 1;
+	LOG_DEBUG("Fused %d instructions at address 0x%04X (sequence kind : %s).", Instructions_Count, Address, Pointer_String_Processor_Fusion_Names[Pointer_Sequence->Fusion]);
+}
+
+/** Execute a whole fused instruction sequence, leaving registers and Program Counter in the same state than if the instructions were executed one by one.
+ * @param Pointer_Sequence The sequence to execute.
+ * @return How many instructions were executed.
+ */
+static int ProcessorExecuteFusedSequence(TProcessorFusedSequence *Pointer_Sequence)
+{
+	unsigned short *Pointer_Instructions = Pointer_Sequence->Instructions;
+	int Executed_Instructions_Count, i, Is_Equal, Sequence_Address;
+	
+	Sequence_Address = Processor_Register_Program_Counter;
+	LOG_DEBUG("Executing fused instruction sequence at address 0x%04X (sequence kind : %s).", Sequence_Address, Pointer_String_Processor_Fusion_Names[Pointer_Sequence->Fusion]);
+	
+	switch (Pointer_Sequence->Fusion)
+	{
+		case PROCESSOR_FUSION_LOAD_I_DRAW:
+			Processor_Register_I = Pointer_Instructions[0] & 0x0FFF;
+			DisplayDrawSprite((Pointer_Instructions[1] & 0x0F00) >> 8, (Pointer_Instructions[1] & 0x00F0) >> 4, Processor_Register_I, Pointer_Instructions[1] & 0x000F); // Same behavior than the standalone DRW instruction
+			Processor_Register_Program_Counter = Sequence_Address + 4;
+			Executed_Instructions_Count = 2;
+			break;
+			
+		case PROCESSOR_FUSION_LOAD_REGISTERS:
+			for (i = 0; i < Pointer_Sequence->Instructions_Count; i++) Processor_Registers_Vk[(Pointer_Instructions[i] & 0x0F00) >> 8] = (unsigned char) Pointer_Instructions[i];
+			Processor_Register_Program_Counter = Sequence_Address + Pointer_Sequence->Instructions_Count * 2;
+			Executed_Instructions_Count = Pointer_Sequence->Instructions_Count;
+			break;
+			
+		case PROCESSOR_FUSION_COUNTED_LOOP:
+			Processor_Registers_Vk[(Pointer_Instructions[0] & 0x0F00) >> 8] += (unsigned char) Pointer_Instructions[0];
+			Is_Equal = Processor_Registers_Vk[(Pointer_Instructions[1] & 0x0F00) >> 8] == (unsigned char) Pointer_Instructions[1];
+			// The skip instruction jumps over the JP instruction when its condition is true (SE skips on equality, SNE on difference)
+			if (((Pointer_Instructions[1] >> 12) == 3) == Is_Equal)
+			{
+				Processor_Register_Program_Counter = Sequence_Address + 6;
+				Executed_Instructions_Count = 2;
+			}
+			else
+			{
+				Processor_Register_Program_Counter = Pointer_Instructions[2] & 0x0FFF;
+				Executed_Instructions_Count = 3;
+			}
+			break;
+			
+		default:
+			LOG_ERROR("Error : unknown fused instruction sequence kind %d at PC=0x%04X, aborting program.", Pointer_Sequence->Fusion, Processor_Register_Program_Counter);
+			exit(EXIT_FAILURE);
+	}
+	
+	atomic_fetch_add_explicit(&Processor_Fusion_Executions_Counts[Pointer_Sequence->Fusion], 1, memory_order_relaxed);
+	for (i = 0; i < Executed_Instructions_Count; i++) PROFILER_RECORD_INSTRUCTION(Sequence_Address + i * 2, Pointer_Instructions[i]);
+	
+	LOG_DEBUG("New Program Counter value : 0x%04X.", Processor_Register_Program_Counter);
+	return Executed_Instructions_Count;
+}
+
 //-------------------------------------------------------------------------------------------------
 // Public functions
 //-------------------------------------------------------------------------------------------------
-void ProcessorExecuteNextInstruction(void)
+int ProcessorExecuteNextInstruction(void)
 {
 	unsigned short Instruction, Temporary_Word, Temporary_Byte_1, Temporary_Byte_2;
+	TProcessorFusedSequence *Pointer_Sequence;
+	int i;
+	
+	// A computed jump can lead outside of the RAM
+	if (Processor_Register_Program_Counter >= MEMORY_RAM_TOTAL_SIZE)
+	{
+		LOG_ERROR("Error : Program Counter 0x%04X is outside of the RAM, aborting program.", Processor_Register_Program_Counter);
+		exit(EXIT_FAILURE);
+	}
+	
+	// Execute the whole instruction sequence at once if possible
+	Pointer_Sequence = &Processor_Fused_Sequences[Processor_Register_Program_Counter];
+	if (!Pointer_Sequence->Is_Analyzed) ProcessorAnalyzeInstructionSequence(Processor_Register_Program_Counter);
+	if (Pointer_Sequence->Is_Fused) return ProcessorExecuteFusedSequence(Pointer_Sequence);
 	
 	// Fetch instruction from memory
 	LOG_DEBUG("Loading next instruction at address 0x%04X...", Processor_Register_Program_Counter);
 	Instruction = MemoryRAMReadWord(Processor_Register_Program_Counter);
 	LOG_DEBUG("Instruction code : 0x%04X.", Instruction);
+	PROFILER_RECORD_INSTRUCTION(Processor_Register_Program_Counter, Instruction);
 	
 	// Decode and execute instruction
 	switch (Instruction >> 12) // Extract opcode
@@ -53,7 +204,8 @@ void ProcessorExecuteNextInstruction(void)
 			else if (Instruction == 0x00EE)
 			{
 				LOG_DEBUG("Decoded instruction : RET.");
-				// TODO
+				Processor_Register_Program_Counter = MemoryStackPop();
+				PROFILER_LEAVE_SUBROUTINE();
 			}
 			else goto Unknown_Instruction;
 			break;
@@ -73,7 +225,9 @@ void ProcessorExecuteNextInstruction(void)
 			Temporary_Word = Instruction & 0x0FFF;
 			LOG_DEBUG("Decoded instruction : CALL 0x%04X.", Temporary_Word);
 			// Execute instruction
-			// TODO
+			MemoryStackPush(Processor_Register_Program_Counter + 2); // Return to the instruction following the CALL
+			Processor_Register_Program_Counter = Temporary_Word;
+			PROFILER_ENTER_SUBROUTINE(Temporary_Word);
 			break;
 			
 		// SE Vx, byte
@@ -239,15 +393,91 @@ void ProcessorExecuteNextInstruction(void)
 			Processor_Register_Program_Counter += 2;
 			break;
 			
+		case 0xF:
+			// There are several instructions, last byte allows to differentiate them
+			switch (Instruction & 0x00FF)
+			{
+				// LD B, Vx
+				case 0x33:
+					// Decode instruction
+					Temporary_Byte_1 = (Instruction & 0x0F00) >> 8;
+					LOG_DEBUG("Decoded instruction : LD B, V%X.", Temporary_Byte_1);
+					// Execute instruction
+					if (Processor_Register_I + 2 >= MEMORY_RAM_TOTAL_SIZE) goto Invalid_Memory_Access;
+					Temporary_Byte_2 = Processor_Registers_Vk[Temporary_Byte_1]; // Recycle Temporary_Byte_2 variable
+					MemoryRAMWriteByte(Processor_Register_I, Temporary_Byte_2 / 100);
+					MemoryRAMWriteByte(Processor_Register_I + 1, (Temporary_Byte_2 / 10) % 10);
+					MemoryRAMWriteByte(Processor_Register_I + 2, Temporary_Byte_2 % 10);
+					Processor_Register_Program_Counter += 2;
+					break;
+					
+				// LD [I], Vx
+				case 0x55:
+					// Decode instruction
+					Temporary_Byte_1 = (Instruction & 0x0F00) >> 8;
+					LOG_DEBUG("Decoded instruction : LD [I], V%X.", Temporary_Byte_1);
+					// Execute instruction
+					if (Processor_Register_I + Temporary_Byte_1 >= MEMORY_RAM_TOTAL_SIZE) goto Invalid_Memory_Access;
+					for (i = 0; i <= Temporary_Byte_1; i++) MemoryRAMWriteByte(Processor_Register_I + i, Processor_Registers_Vk[i]);
+					Processor_Register_Program_Counter += 2;
+					break;
+					
+				// LD Vx, [I]
+				case 0x65:
+					// Decode instruction
+					Temporary_Byte_1 = (Instruction & 0x0F00) >> 8;
+					LOG_DEBUG("Decoded instruction : LD V%X, [I].", Temporary_Byte_1);
+					// Execute instruction
+					if (Processor_Register_I + Temporary_Byte_1 >= MEMORY_RAM_TOTAL_SIZE) goto Invalid_Memory_Access;
+					for (i = 0; i <= Temporary_Byte_1; i++) Processor_Registers_Vk[i] = MemoryRAMReadByte(Processor_Register_I + i);
+					Processor_Register_Program_Counter += 2;
+					break;
+					
+				// TODO
+				
+				default:
+					goto Unknown_Instruction;
+			}
+			break;
+			
 		default:
 			goto Unknown_Instruction;
 	}
 	
 	LOG_DEBUG("New Program Counter value : 0x%04X.", Processor_Register_Program_Counter);
 	
-	return;
+	return 1;
 	
 Unknown_Instruction:
 	LOG_ERROR("Error : unknown instruction 0x%04X at PC=0x%04X, aborting program.", Instruction, Processor_Register_Program_Counter);
 	exit(EXIT_FAILURE);
+	
+Invalid_Memory_Access:
+	LOG_ERROR("Error : instruction 0x%04X at PC=0x%04X accesses memory outside of the RAM (I=0x%04X), aborting program.", Instruction, Processor_Register_Program_Counter, Processor_Register_I);
+	exit(EXIT_FAILURE);
+}
+
+void ProcessorInvalidateFusedSequences(int Address, int Size)
+{
+	int First_Address, Last_Address;
+	
+	// Find the first sequence that can contain the area first byte
+	First_Address = Address - (PROCESSOR_FUSED_SEQUENCE_MAXIMUM_INSTRUCTIONS_COUNT * 2 - 1);
+	if (First_Address < 0) First_Address = 0;
+	
+	// The last sequence to forget is the one starting on the area last byte
+	Last_Address = Address + Size - 1;
+	if (Last_Address >= MEMORY_RAM_TOTAL_SIZE) Last_Address = MEMORY_RAM_TOTAL_SIZE - 1;
+	
+	for (; First_Address <= Last_Address; First_Address++) Processor_Fused_Sequences[First_Address].Is_Analyzed = 0;
+}
+
+unsigned long long ProcessorGetFusionExecutionsCount(TProcessorFusion Fusion)
+{
+	return atomic_load_explicit(&Processor_Fusion_Executions_Counts[Fusion], memory_order_relaxed);
+}
+
+char *ProcessorGetFusionName(TProcessorFusion Fusion)
+{
+	return Pointer_String_Processor_Fusion_Names[Fusion];
 }
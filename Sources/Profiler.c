@@ -0,0 +1,398 @@
+/** @file Profiler.c
+ * @see Profiler.h for description.
+ * @author Adrien RICCIARDI
+ */
+#ifdef PROFILER_ENABLED
+
+#include <errno.h>
+#include <Log.h>
+#include <Memory.h>
+#include <Profiler.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** How many opcode classes exist (an opcode class is identified by the instruction most significant nibble). */
+#define PROFILER_OPCODE_CLASSES_COUNT 16
+
+/** Maximum amount of distinct call stacks that can be tracked. */
+#define PROFILER_CALL_TREE_MAXIMUM_NODES_COUNT 1024
+
+/** The call tree root node index, it stands for the code executed outside of any subroutine. */
+#define PROFILER_CALL_TREE_ROOT_NODE_INDEX 0
+
+//-------------------------------------------------------------------------------------------------
+// Private types
+//-------------------------------------------------------------------------------------------------
+/** A call tree node represents a unique call stack. */
+typedef struct
+{
+	int Parent_Node_Index; //!< The caller node, or -1 for the root node.
+	int Subroutine_Address; //!< The subroutine this node was entered in.
+	atomic_ullong Samples_Count; //!< How many instructions were executed with this exact call stack.
+} TProfilerCallTreeNode;
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** How many times each RAM address has been executed. All counters are written by the processor thread only, but they can be read by another thread when the profile is saved, so they are accessed with relaxed atomic operations. */
+static atomic_ullong Profiler_Address_Execution_Counts[MEMORY_RAM_TOTAL_SIZE];
+
+/** The last instruction code executed at each RAM address, so the listing shows the executed code even if the program modified it afterwards (and RAM is not read while the processor is running). */
+static _Atomic unsigned short Profiler_Address_Instructions[MEMORY_RAM_TOTAL_SIZE];
+
+/** How many times each opcode class has been executed. */
+static atomic_ullong Profiler_Opcode_Class_Execution_Counts[PROFILER_OPCODE_CLASSES_COUNT];
+
+/** Human-readable name of each opcode class. */
+static char *Pointer_String_Profiler_Opcode_Class_Names[PROFILER_OPCODE_CLASSES_COUNT] =
+{
+	"0nnn (CLS, RET, SYS)",
+	"1nnn (JP addr)",
+	"2nnn (CALL addr)",
+	"3xkk (SE Vx, byte)",
+	"4xkk (SNE Vx, byte)",
+	"5xy0 (SE Vx, Vy)",
+	"6xkk (LD Vx, byte)",
+	"7xkk (ADD Vx, byte)",
+	"8xyn (arithmetic and logic)",
+	"9xy0 (SNE Vx, Vy)",
+	"Annn (LD I, addr)",
+	"Bnnn (JP V0, addr)",
+	"Cxkk (RND Vx, byte)",
+	"Dxyn (DRW Vx, Vy, nibble)",
+	"Ex?? (SKP, SKNP)",
+	"Fx?? (timers, keyboard, I and memory)"
+};
+
+/** All call stacks encountered so far, the root node is always present. */
+static TProfilerCallTreeNode Profiler_Call_Tree_Nodes[PROFILER_CALL_TREE_MAXIMUM_NODES_COUNT] =
+{
+	{ -1, MEMORY_RAM_PROGRAM_ENTRY_POINT, 0 }
+};
+/** How many call tree nodes are used. A node is published by incrementing this count with release semantics once the node is fully initialized, so readers acquiring the count only see initialized nodes. */
+static atomic_int Profiler_Call_Tree_Nodes_Count = 1;
+/** The node corresponding to the current call stack. */
+static int Profiler_Call_Tree_Current_Node_Index = PROFILER_CALL_TREE_ROOT_NODE_INDEX;
+/** How many nested subroutines could not be tracked because the call tree was full. Their samples are assigned to the deepest tracked subroutine. */
+static int Profiler_Untracked_Calls_Depth = 0;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Increment a counter that is written by a single thread (this avoids the cost of an atomic read-modify-write operation).
+ * @param Pointer_Counter The counter to increment.
+ */
+static void ProfilerIncrementCounter(atomic_ullong *Pointer_Counter)
+{
+	atomic_store_explicit(Pointer_Counter, atomic_load_explicit(Pointer_Counter, memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+/** Convert an instruction to its assembly mnemonic.
+ * @param Instruction The instruction code.
+ * @param Pointer_String_Buffer On output, contain the instruction mnemonic.
+ * @param Buffer_Size The output buffer size in bytes.
+ */
+static void ProfilerDisassembleInstruction(unsigned short Instruction, char *Pointer_String_Buffer, int Buffer_Size)
+{
+	int X, Y, Byte, Address;
+	
+	// Decode all possible operands once, each instruction will pick the ones it needs
+	X = (Instruction & 0x0F00) >> 8;
+	Y = (Instruction & 0x00F0) >> 4;
+	Byte = Instruction & 0x00FF;
+	Address = Instruction & 0x0FFF;
+	
+	switch (Instruction >> 12)
+	{
+		case 0:
+			if (Instruction == 0x00E0) snprintf(Pointer_String_Buffer, Buffer_Size, "CLS");
+			else if (Instruction == 0x00EE) snprintf(Pointer_String_Buffer, Buffer_Size, "RET");
+			else snprintf(Pointer_String_Buffer, Buffer_Size, "SYS 0x%03X", Address);
+			return;
+			
+		case 1:
+			snprintf(Pointer_String_Buffer, Buffer_Size, "JP 0x%03X", Address);
+			return;
+			
+		case 2:
+			snprintf(Pointer_String_Buffer, Buffer_Size, "CALL 0x%03X", Address);
+			return;
+			
+		case 3:
+			snprintf(Pointer_String_Buffer, Buffer_Size, "SE V%X, %d", X, Byte);
+			return;
+			
+		case 4:
+			snprintf(Pointer_String_Buffer, Buffer_Size, "SNE V%X, %d", X, Byte);
+			return;
+			
+		case 5:
+			if ((Instruction & 0x000F) != 0) break;
+			snprintf(Pointer_String_Buffer, Buffer_Size, "SE V%X, V%X", X, Y);
+			return;
+			
+		case 6:
+			snprintf(Pointer_String_Buffer, Buffer_Size, "LD V%X, %d", X, Byte);
+			return;
+			
+		case 7:
+			snprintf(Pointer_String_Buffer, Buffer_Size, "ADD V%X, %d", X, Byte);
+			return;
+			
+		case 8:
+			switch (Instruction & 0x000F)
+			{
+				case 0:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "LD V%X, V%X", X, Y);
+					return;
+				case 1:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "OR V%X, V%X", X, Y);
+					return;
+				case 2:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "AND V%X, V%X", X, Y);
+					return;
+				case 3:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "XOR V%X, V%X", X, Y);
+					return;
+				case 4:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "ADD V%X, V%X", X, Y);
+					return;
+				case 5:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "SUB V%X, V%X", X, Y);
+					return;
+				case 6:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "SHR V%X", X);
+					return;
+				case 7:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "SUBN V%X, V%X", X, Y);
+					return;
+				case 0xE:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "SHL V%X", X);
+					return;
+				default:
+					break;
+			}
+			break;
+			
+		case 9:
+			if ((Instruction & 0x000F) != 0) break;
+			snprintf(Pointer_String_Buffer, Buffer_Size, "SNE V%X, V%X", X, Y);
+			return;
+			
+		case 0xA:
+			snprintf(Pointer_String_Buffer, Buffer_Size, "LD I, 0x%03X", Address);
+			return;
+			
+		case 0xB:
+			snprintf(Pointer_String_Buffer, Buffer_Size, "JP V0, 0x%03X", Address);
+			return;
+			
+		case 0xC:
+			snprintf(Pointer_String_Buffer, Buffer_Size, "RND V%X, 0x%02X", X, Byte);
+			return;
+			
+		case 0xD:
+			snprintf(Pointer_String_Buffer, Buffer_Size, "DRW V%X, V%X, %d", X, Y, Instruction & 0x000F);
+			return;
+			
+		case 0xE:
+			if (Byte == 0x9E) snprintf(Pointer_String_Buffer, Buffer_Size, "SKP V%X", X);
+			else if (Byte == 0xA1) snprintf(Pointer_String_Buffer, Buffer_Size, "SKNP V%X", X);
+			else break;
+			return;
+			
+		case 0xF:
+			switch (Byte)
+			{
+				case 0x07:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "LD V%X, DT", X);
+					return;
+				case 0x0A:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "LD V%X, K", X);
+					return;
+				case 0x15:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "LD DT, V%X", X);
+					return;
+				case 0x18:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "LD ST, V%X", X);
+					return;
+				case 0x1E:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "ADD I, V%X", X);
+					return;
+				case 0x29:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "LD F, V%X", X);
+					return;
+				case 0x33:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "LD B, V%X", X);
+					return;
+				case 0x55:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "LD [I], V%X", X);
+					return;
+				case 0x65:
+					snprintf(Pointer_String_Buffer, Buffer_Size, "LD V%X, [I]", X);
+					return;
+				default:
+					break;
+			}
+			break;
+	}
+	
+	// The instruction is not part of the Chip-8 instruction set
+	snprintf(Pointer_String_Buffer, Buffer_Size, "DW 0x%04X", Instruction);
+}
+
+/** Write the frames of a call stack from the outermost to the innermost one, separated by semicolons.
+ * @param Pointer_File The file to write to.
+ * @param Node_Index The innermost call stack node.
+ */
+static void ProfilerWriteFoldedStack(FILE *Pointer_File, int Node_Index)
+{
+	// Print callers first
+	if (Profiler_Call_Tree_Nodes[Node_Index].Parent_Node_Index >= 0)
+	{
+		ProfilerWriteFoldedStack(Pointer_File, Profiler_Call_Tree_Nodes[Node_Index].Parent_Node_Index);
+		fputc(';', Pointer_File);
+	}
+	fprintf(Pointer_File, "0x%03X", Profiler_Call_Tree_Nodes[Node_Index].Subroutine_Address);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+void ProfilerRecordInstruction(int Address, unsigned short Instruction)
+{
+	// Program Counter is not bounds-checked by release builds, so make sure to stay inside the array
+	if ((Address >= 0) && (Address < MEMORY_RAM_TOTAL_SIZE))
+	{
+		ProfilerIncrementCounter(&Profiler_Address_Execution_Counts[Address]);
+		atomic_store_explicit(&Profiler_Address_Instructions[Address], Instruction, memory_order_relaxed);
+	}
+	ProfilerIncrementCounter(&Profiler_Opcode_Class_Execution_Counts[Instruction >> 12]);
+	ProfilerIncrementCounter(&Profiler_Call_Tree_Nodes[Profiler_Call_Tree_Current_Node_Index].Samples_Count);
+}
+
+void ProfilerEnterSubroutine(int Address)
+{
+	int i, Nodes_Count;
+	
+	// Stay on the deepest tracked node if the call tree is already full
+	if (Profiler_Untracked_Calls_Depth > 0)
+	{
+		Profiler_Untracked_Calls_Depth++;
+		return;
+	}
+	
+	// Reuse the call stack if it has already been seen (this thread is the only one to modify the nodes count)
+	Nodes_Count = atomic_load_explicit(&Profiler_Call_Tree_Nodes_Count, memory_order_relaxed);
+	for (i = 1; i < Nodes_Count; i++)
+	{
+		if ((Profiler_Call_Tree_Nodes[i].Parent_Node_Index == Profiler_Call_Tree_Current_Node_Index) && (Profiler_Call_Tree_Nodes[i].Subroutine_Address == Address))
+		{
+			Profiler_Call_Tree_Current_Node_Index = i;
+			return;
+		}
+	}
+	
+	// This is a new call stack
+	if (Nodes_Count >= PROFILER_CALL_TREE_MAXIMUM_NODES_COUNT)
+	{
+		LOG_DEBUG("Profiler call tree is full, subroutine 0x%03X samples will be assigned to its caller.", Address);
+		Profiler_Untracked_Calls_Depth = 1;
+		return;
+	}
+	Profiler_Call_Tree_Nodes[Nodes_Count].Parent_Node_Index = Profiler_Call_Tree_Current_Node_Index;
+	Profiler_Call_Tree_Nodes[Nodes_Count].Subroutine_Address = Address;
+	Profiler_Call_Tree_Current_Node_Index = Nodes_Count;
+	atomic_store_explicit(&Profiler_Call_Tree_Nodes_Count, Nodes_Count + 1, memory_order_release);
+}
+
+void ProfilerLeaveSubroutine(void)
+{
+	if (Profiler_Untracked_Calls_Depth > 0)
+	{
+		Profiler_Untracked_Calls_Depth--;
+		return;
+	}
+	
+	// A RET executed outside of any subroutine will make the processor abort, so stay on the root node
+	if (Profiler_Call_Tree_Current_Node_Index != PROFILER_CALL_TREE_ROOT_NODE_INDEX) Profiler_Call_Tree_Current_Node_Index = Profiler_Call_Tree_Nodes[Profiler_Call_Tree_Current_Node_Index].Parent_Node_Index;
+}
+
+int ProfilerSaveFoldedStacks(char *Pointer_String_File_Name)
+{
+	FILE *Pointer_File;
+	int i, Nodes_Count;
+	unsigned long long Samples_Count;
+	
+	Pointer_File = fopen(Pointer_String_File_Name, "w");
+	if (Pointer_File == NULL)
+	{
+		LOG_ERROR("Failed to create '%s' file (%s).", Pointer_String_File_Name, strerror(errno));
+		return -1;
+	}
+	
+	// Output only the call stacks in which some instructions were executed (a subroutine only calling other subroutines will appear as a frame of its callees stacks)
+	Nodes_Count = atomic_load_explicit(&Profiler_Call_Tree_Nodes_Count, memory_order_acquire);
+	for (i = 0; i < Nodes_Count; i++)
+	{
+		Samples_Count = atomic_load_explicit(&Profiler_Call_Tree_Nodes[i].Samples_Count, memory_order_relaxed);
+		if (Samples_Count == 0) continue;
+		
+		ProfilerWriteFoldedStack(Pointer_File, i);
+		fprintf(Pointer_File, " %llu\n", Samples_Count);
+	}
+	
+	fclose(Pointer_File);
+	return 0;
+}
+
+int ProfilerSaveAnnotatedDisassembly(char *Pointer_String_File_Name)
+{
+	FILE *Pointer_File;
+	int Address, Previous_Executed_Address = -1;
+	unsigned long long Total_Executed_Instructions_Count = 0, Execution_Count, Opcode_Class_Execution_Counts[PROFILER_OPCODE_CLASSES_COUNT];
+	unsigned short Instruction;
+	char String_Mnemonic[32];
+	
+	Pointer_File = fopen(Pointer_String_File_Name, "w");
+	if (Pointer_File == NULL)
+	{
+		LOG_ERROR("Failed to create '%s' file (%s).", Pointer_String_File_Name, strerror(errno));
+		return -1;
+	}
+	
+	// Opcode classes summary, take a snapshot of the counters to get consistent percentages while the processor is still running
+	for (Address = 0; Address < PROFILER_OPCODE_CLASSES_COUNT; Address++) // Recycle Address variable
+	{
+		Opcode_Class_Execution_Counts[Address] = atomic_load_explicit(&Profiler_Opcode_Class_Execution_Counts[Address], memory_order_relaxed);
+		Total_Executed_Instructions_Count += Opcode_Class_Execution_Counts[Address];
+	}
+	fprintf(Pointer_File, "; Executed instructions : %llu\n;\n; Opcode class                            Count  Percentage\n", Total_Executed_Instructions_Count);
+	if (Total_Executed_Instructions_Count == 0) Total_Executed_Instructions_Count = 1; // Avoid a division by zero when computing percentages
+	for (Address = 0; Address < PROFILER_OPCODE_CLASSES_COUNT; Address++) fprintf(Pointer_File, "; %-37s %12llu %10.2f%%\n", Pointer_String_Profiler_Opcode_Class_Names[Address], Opcode_Class_Execution_Counts[Address], Opcode_Class_Execution_Counts[Address] * 100.0 / Total_Executed_Instructions_Count);
+	
+	// Executed instructions listing, skipped RAM areas are marked with an ellipsis
+	fprintf(Pointer_File, ";\n; Address  Code         Count  Percentage  Instruction\n");
+	for (Address = 0; Address < MEMORY_RAM_TOTAL_SIZE; Address++)
+	{
+		Execution_Count = atomic_load_explicit(&Profiler_Address_Execution_Counts[Address], memory_order_relaxed);
+		if (Execution_Count == 0) continue;
+		
+		// Tell that some instructions were not executed since the previously listed one
+		if (Address > Previous_Executed_Address + 2) fprintf(Pointer_File, "  ...\n");
+		Previous_Executed_Address = Address;
+		
+		Instruction = atomic_load_explicit(&Profiler_Address_Instructions[Address], memory_order_relaxed);
+		ProfilerDisassembleInstruction(Instruction, String_Mnemonic, sizeof(String_Mnemonic));
+		fprintf(Pointer_File, "  0x%03X    %04X  %12llu %10.2f%%  %s\n", Address, Instruction, Execution_Count, Execution_Count * 100.0 / Total_Executed_Instructions_Count, String_Mnemonic);
+	}
+	
+	fclose(Pointer_File);
+	return 0;
+}
+
+#endif
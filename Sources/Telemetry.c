@@ -0,0 +1,560 @@
+/** @file Telemetry.c
+ * @see Telemetry.h for description.
+ * @author Adrien RICCIARDI
+ */
+#include <Display.h>
+#include <errno.h>
+#include <limits.h>
+#include <Log.h>
+#include <poll.h>
+#include <Processor.h>
+#include <SDL2/SDL.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <Telemetry.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------------------------------
+// Private constants
+//-------------------------------------------------------------------------------------------------
+/** Speed of the original Chip-8 interpreters in instructions per second, used as the reference to compute the emulation speed ratio. */
+#define TELEMETRY_NOMINAL_INSTRUCTIONS_PER_SECOND 500
+
+/** The display refresh rate to assume when SDL can't tell it, in Hz. */
+#define TELEMETRY_DEFAULT_DISPLAY_REFRESH_RATE 60
+
+/** How many buckets a histogram has. Bucket 0 holds durations lower than 2us, bucket n holds durations in [2^n, 2^(n + 1)[ us, the last bucket holds all longer durations. */
+#define TELEMETRY_HISTOGRAM_BUCKETS_COUNT 18
+
+/** Time between two rates computations and statistics file updates, in milliseconds. */
+#define TELEMETRY_PUBLICATION_PERIOD_MILLISECONDS 1000
+
+/** The size of the text buffer holding a complete statistics report. */
+#define TELEMETRY_REPORT_MAXIMUM_SIZE 4096
+
+/** The environment variable telling where to write the statistics file. */
+#define TELEMETRY_ENVIRONMENT_VARIABLE_STATISTICS_FILE "CHIP8_EMULATOR_STATS_FILE"
+/** The environment variable telling where to create the statistics UNIX socket. */
+#define TELEMETRY_ENVIRONMENT_VARIABLE_STATISTICS_SOCKET "CHIP8_EMULATOR_STATS_SOCKET"
+
+/** How many real screen pixels an overlay font pixel takes. */
+#define TELEMETRY_OVERLAY_SCALING_FACTOR 4
+/** Overlay font character width in font pixels. */
+#define TELEMETRY_OVERLAY_CHARACTER_WIDTH 3
+/** Overlay font character height in font pixels. */
+#define TELEMETRY_OVERLAY_CHARACTER_HEIGHT 5
+/** Overlay histogram bars maximum height in screen pixels. */
+#define TELEMETRY_OVERLAY_HISTOGRAM_HEIGHT 48
+/** Overlay histogram bar width in screen pixels. */
+#define TELEMETRY_OVERLAY_HISTOGRAM_BAR_WIDTH 8
+/** Overlay elements distance to the window borders and between them, in screen pixels. */
+#define TELEMETRY_OVERLAY_MARGIN 8
+
+//-------------------------------------------------------------------------------------------------
+// Private variables
+//-------------------------------------------------------------------------------------------------
+/** All counters are updated with relaxed atomic operations, as they are independent from each other and are only read to be displayed. */
+static atomic_ullong Telemetry_Executed_Instructions_Count;
+/** How many times the processor was asked to execute instructions (a dispatch can execute a whole fused instruction sequence). */
+static atomic_ullong Telemetry_Processor_Dispatches_Count;
+/** Processor thread cumulated waiting time in microseconds. */
+static atomic_ullong Telemetry_Processor_Stall_Time;
+/** How many frames have been rendered. */
+static atomic_ullong Telemetry_Frames_Count;
+/** How many frames missed a display refresh. */
+static atomic_ullong Telemetry_Dropped_Frames_Count;
+/** Distribution of the time between two frames. */
+static atomic_ullong Telemetry_Frame_Time_Histogram[TELEMETRY_HISTOGRAM_BUCKETS_COUNT];
+/** Distribution of SDL_RenderPresent() execution time. */
+static atomic_ullong Telemetry_Present_Latency_Histogram[TELEMETRY_HISTOGRAM_BUCKETS_COUNT];
+/** Instructions executed during the last publication period, converted to a per second rate. */
+static atomic_ullong Telemetry_Instructions_Per_Second;
+
+/** A frame lasting more than this duration in microseconds missed at least one display refresh (the renderer is synchronized with the display refresh rate). */
+static unsigned long long Telemetry_Dropped_Frame_Threshold;
+
+/** Cache SDL performance counter frequency to convert ticks to microseconds. */
+static Uint64 Telemetry_Performance_Counter_Frequency;
+/** When the telemetry was started, in SDL performance counter ticks. */
+static Uint64 Telemetry_Start_Timestamp;
+
+/** Where to write the statistics file, or NULL if the file is disabled. */
+static char *Pointer_String_Telemetry_Statistics_File_Name;
+/** Where the statistics socket is bound, or NULL if the socket is disabled. */
+static char *Pointer_String_Telemetry_Statistics_Socket_Name;
+/** The socket listening for statistics clients, or -1 if the socket is disabled. It is never modified once the telemetry thread is started. */
+static int Telemetry_Statistics_Socket = -1;
+
+/** Tell whether the overlay must be drawn (only accessed by the main thread). */
+static int Telemetry_Is_Overlay_Enabled = 0;
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//-------------------------------------------------------------------------------------------------
+/** Convert SDL performance counter ticks to microseconds without overflowing on long durations.
+ * @param Ticks The duration to convert.
+ * @return The duration in microseconds.
+ */
+static unsigned long long TelemetryConvertTicksToMicroseconds(Uint64 Ticks)
+{
+	return (Ticks / Telemetry_Performance_Counter_Frequency) * 1000000ULL + (Ticks % Telemetry_Performance_Counter_Frequency) * 1000000ULL / Telemetry_Performance_Counter_Frequency;
+}
+
+/** Add a duration to a histogram.
+ * @param Pointer_Histogram The histogram to update.
+ * @param Duration The duration in microseconds.
+ */
+static void TelemetryAddToHistogram(atomic_ullong *Pointer_Histogram, unsigned long long Duration)
+{
+	int Bucket_Index = 0;
+	
+	// Find the duration base 2 logarithm
+	while ((Duration >= 2) && (Bucket_Index < TELEMETRY_HISTOGRAM_BUCKETS_COUNT - 1))
+	{
+		Duration >>= 1;
+		Bucket_Index++;
+	}
+	
+	atomic_fetch_add_explicit(&Pointer_Histogram[Bucket_Index], 1, memory_order_relaxed);
+}
+
+/** Append a histogram to a statistics report.
+ * @param Pointer_String_Report The report to append to.
+ * @param Report_Size The report buffer size in bytes.
+ * @param Length The report current length.
+ * @param Pointer_String_Name The histogram name.
+ * @param Pointer_Histogram The histogram to append.
+ * @return The report new length.
+ */
+static int TelemetryFormatHistogram(char *Pointer_String_Report, int Report_Size, int Length, char *Pointer_String_Name, atomic_ullong *Pointer_Histogram)
+{
+	int i;
+	
+	for (i = 0; i < TELEMETRY_HISTOGRAM_BUCKETS_COUNT; i++)
+	{
+		if (Length >= Report_Size) break;
+		
+		// The last bucket has no upper bound
+		if (i < TELEMETRY_HISTOGRAM_BUCKETS_COUNT - 1) Length += snprintf(Pointer_String_Report + Length, Report_Size - Length, "%s_us_lt_%llu %llu\n", Pointer_String_Name, 1ULL << (i + 1), atomic_load_explicit(&Pointer_Histogram[i], memory_order_relaxed));
+		else Length += snprintf(Pointer_String_Report + Length, Report_Size - Length, "%s_us_ge_%llu %llu\n", Pointer_String_Name, 1ULL << i, atomic_load_explicit(&Pointer_Histogram[i], memory_order_relaxed));
+	}
+	
+	return Length;
+}
+
+/** Create a text report of all counters, one "name value" pair per line.
+ * @param Pointer_String_Report On output, contain the report.
+ * @param Report_Size The report buffer size in bytes.
+ * @return The report length.
+ */
+static int TelemetryFormatReport(char *Pointer_String_Report, int Report_Size)
+{
+	unsigned long long Instructions_Per_Second;
+	int Length, Fusion;
+	
+	Instructions_Per_Second = atomic_load_explicit(&Telemetry_Instructions_Per_Second, memory_order_relaxed);
+	Length = snprintf(Pointer_String_Report, Report_Size, "uptime_us %llu\n"
+		"instructions_total %llu\n"
+		"instructions_per_second %llu\n"
+		"dispatches_total %llu\n"
+		"speed_ratio %.3f\n"
+		"processor_stall_us_total %llu\n"
+		"frames_total %llu\n"
+		"frames_dropped_total %llu\n",
+		TelemetryConvertTicksToMicroseconds(SDL_GetPerformanceCounter() - Telemetry_Start_Timestamp),
+		atomic_load_explicit(&Telemetry_Executed_Instructions_Count, memory_order_relaxed),
+		Instructions_Per_Second,
+		atomic_load_explicit(&Telemetry_Processor_Dispatches_Count, memory_order_relaxed),
+		(double) Instructions_Per_Second / TELEMETRY_NOMINAL_INSTRUCTIONS_PER_SECOND,
+		atomic_load_explicit(&Telemetry_Processor_Stall_Time, memory_order_relaxed),
+		atomic_load_explicit(&Telemetry_Frames_Count, memory_order_relaxed),
+		atomic_load_explicit(&Telemetry_Dropped_Frames_Count, memory_order_relaxed));
+	Length = TelemetryFormatHistogram(Pointer_String_Report, Report_Size, Length, "frame_time", Telemetry_Frame_Time_Histogram);
+	Length = TelemetryFormatHistogram(Pointer_String_Report, Report_Size, Length, "present_latency", Telemetry_Present_Latency_Histogram);
+	
+	// Tell how often each instruction sequence was executed in a single dispatch
+	for (Fusion = 0; Fusion < PROCESSOR_FUSIONS_COUNT; Fusion++)
+	{
+		if (Length >= Report_Size) break;
+		Length += snprintf(Pointer_String_Report + Length, Report_Size - Length, "fusion_%s_total %llu\n", ProcessorGetFusionName(Fusion), ProcessorGetFusionExecutionsCount(Fusion));
+	}
+	
+	// snprintf() returns the length the string would have had without truncation
+	if (Length >= Report_Size) Length = Report_Size - 1;
+	return Length;
+}
+
+/** Replace the statistics file content by a new report. The report is written to a temporary file renamed afterwards, so readers never see a partially written file.
+ * @param Pointer_String_Report The report to write.
+ */
+static void TelemetryWriteStatisticsFile(char *Pointer_String_Report)
+{
+	char String_Temporary_File_Name[PATH_MAX];
+	FILE *Pointer_File;
+	
+	snprintf(String_Temporary_File_Name, sizeof(String_Temporary_File_Name), "%s.tmp", Pointer_String_Telemetry_Statistics_File_Name);
+	Pointer_File = fopen(String_Temporary_File_Name, "w");
+	if (Pointer_File == NULL)
+	{
+		LOG_ERROR("Failed to create '%s' file (%s).", String_Temporary_File_Name, strerror(errno));
+		return;
+	}
+	fputs(Pointer_String_Report, Pointer_File);
+	fclose(Pointer_File);
+	
+	if (rename(String_Temporary_File_Name, Pointer_String_Telemetry_Statistics_File_Name) != 0) LOG_ERROR("Failed to rename '%s' to '%s' (%s).", String_Temporary_File_Name, Pointer_String_Telemetry_Statistics_File_Name, strerror(errno));
+}
+
+/** Periodically compute rates and update the statistics file, answer statistics socket clients in the meantime.
+ * @param Pointer This parameter is unused.
+ * @return Unused value.
+ */
+static int TelemetryThreadPublish(void __attribute__((unused)) *Pointer)
+{
+	Uint64 Previous_Timestamp, Current_Timestamp;
+	unsigned long long Previous_Instructions_Count = 0, Current_Instructions_Count, Elapsed_Microseconds;
+	int Client_Socket, Report_Length, Remaining_Milliseconds = TELEMETRY_PUBLICATION_PERIOD_MILLISECONDS;
+	struct pollfd Poll_Descriptor;
+	char String_Report[TELEMETRY_REPORT_MAXIMUM_SIZE];
+	
+	Previous_Timestamp = SDL_GetPerformanceCounter();
+	
+	while (1)
+	{
+		// Wait for the next publication while serving socket clients
+		if (Telemetry_Statistics_Socket >= 0)
+		{
+			Poll_Descriptor.fd = Telemetry_Statistics_Socket;
+			Poll_Descriptor.events = POLLIN;
+			if (poll(&Poll_Descriptor, 1, Remaining_Milliseconds) > 0)
+			{
+				Client_Socket = accept(Telemetry_Statistics_Socket, NULL, NULL);
+				if (Client_Socket >= 0)
+				{
+					Report_Length = TelemetryFormatReport(String_Report, sizeof(String_Report));
+					if (send(Client_Socket, String_Report, Report_Length, MSG_NOSIGNAL) != Report_Length) LOG_DEBUG("Could not send the whole statistics report to the client.");
+					close(Client_Socket);
+				}
+			}
+		}
+		else SDL_Delay(Remaining_Milliseconds);
+		
+		// Is it time to publish ?
+		Current_Timestamp = SDL_GetPerformanceCounter();
+		Elapsed_Microseconds = TelemetryConvertTicksToMicroseconds(Current_Timestamp - Previous_Timestamp);
+		if (Elapsed_Microseconds < TELEMETRY_PUBLICATION_PERIOD_MILLISECONDS * 1000ULL)
+		{
+			Remaining_Milliseconds = TELEMETRY_PUBLICATION_PERIOD_MILLISECONDS - (Elapsed_Microseconds / 1000);
+			continue;
+		}
+		Remaining_Milliseconds = TELEMETRY_PUBLICATION_PERIOD_MILLISECONDS;
+		
+		// Update the rates
+		Current_Instructions_Count = atomic_load_explicit(&Telemetry_Executed_Instructions_Count, memory_order_relaxed);
+		atomic_store_explicit(&Telemetry_Instructions_Per_Second, (Current_Instructions_Count - Previous_Instructions_Count) * 1000000ULL / Elapsed_Microseconds, memory_order_relaxed);
+		Previous_Instructions_Count = Current_Instructions_Count;
+		Previous_Timestamp = Current_Timestamp;
+		
+		if (Pointer_String_Telemetry_Statistics_File_Name != NULL)
+		{
+			TelemetryFormatReport(String_Report, sizeof(String_Report));
+			TelemetryWriteStatisticsFile(String_Report);
+		}
+	}
+	
+	// To make the compiler happy
+	return 0;
+}
+
+/** Get the 3x5 pixels bitmap of an overlay character.
+ * @param Character The character to draw.
+ * @return The character bitmap, rows are stored from the top one to the bottom one starting from bit 14, each row most significant bit is the leftmost pixel. An unknown character results in a blank bitmap.
+ */
+static unsigned short TelemetryGetOverlayCharacterBitmap(char Character)
+{
+	static unsigned short Digits_Bitmaps[10] = { 0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF };
+	
+	if ((Character >= '0') && (Character <= '9')) return Digits_Bitmaps[Character - '0'];
+	
+	switch (Character)
+	{
+		case 'D':
+			return 0x6B6E;
+		case 'I':
+			return 0x7497;
+		case 'O':
+			return Digits_Bitmaps[0];
+		case 'P':
+			return 0x7BE4;
+		case 'R':
+			return 0x6BAD;
+		case 'S':
+			return Digits_Bitmaps[5];
+		case '%':
+			return 0x52A5;
+		case '.':
+			return 0x0002;
+		default:
+			return 0;
+	}
+}
+
+/** Draw a filled rectangle with the current draw color, abort the program on failure.
+ * @param Pointer_Renderer The renderer to draw with.
+ * @param X Rectangle left coordinate.
+ * @param Y Rectangle top coordinate.
+ * @param Width Rectangle width.
+ * @param Height Rectangle height.
+ */
+static void TelemetryOverlayFillRectangle(SDL_Renderer *Pointer_Renderer, int X, int Y, int Width, int Height)
+{
+	SDL_Rect Rectangle;
+	
+	Rectangle.x = X;
+	Rectangle.y = Y;
+	Rectangle.w = Width;
+	Rectangle.h = Height;
+	if (SDL_RenderFillRect(Pointer_Renderer, &Rectangle) != 0)
+	{
+		LOG_ERROR("Failed to render overlay rectangle (%s).", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+}
+
+/** Set the renderer draw color, abort the program on failure.
+ * @param Pointer_Renderer The renderer to configure.
+ * @param Red Red component.
+ * @param Green Green component.
+ * @param Blue Blue component.
+ * @param Alpha Alpha component.
+ */
+static void TelemetryOverlaySetColor(SDL_Renderer *Pointer_Renderer, Uint8 Red, Uint8 Green, Uint8 Blue, Uint8 Alpha)
+{
+	if (SDL_SetRenderDrawColor(Pointer_Renderer, Red, Green, Blue, Alpha) != 0)
+	{
+		LOG_ERROR("Could not set rendering draw color (%s).", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+}
+
+/** Draw a line of text with the current draw color.
+ * @param Pointer_Renderer The renderer to draw with.
+ * @param X Text left coordinate.
+ * @param Y Text top coordinate.
+ * @param Pointer_String_Text The text to draw.
+ */
+static void TelemetryOverlayDrawText(SDL_Renderer *Pointer_Renderer, int X, int Y, char *Pointer_String_Text)
+{
+	unsigned short Bitmap;
+	int Row, Column;
+	
+	while (*Pointer_String_Text != 0)
+	{
+		Bitmap = TelemetryGetOverlayCharacterBitmap(*Pointer_String_Text);
+		for (Row = 0; Row < TELEMETRY_OVERLAY_CHARACTER_HEIGHT; Row++)
+		{
+			for (Column = 0; Column < TELEMETRY_OVERLAY_CHARACTER_WIDTH; Column++)
+			{
+				if (Bitmap & (0x4000 >> (Row * TELEMETRY_OVERLAY_CHARACTER_WIDTH + Column))) TelemetryOverlayFillRectangle(Pointer_Renderer, X + Column * TELEMETRY_OVERLAY_SCALING_FACTOR, Y + Row * TELEMETRY_OVERLAY_SCALING_FACTOR, TELEMETRY_OVERLAY_SCALING_FACTOR, TELEMETRY_OVERLAY_SCALING_FACTOR);
+			}
+		}
+		
+		// Leave a one pixel space between characters
+		X += (TELEMETRY_OVERLAY_CHARACTER_WIDTH + 1) * TELEMETRY_OVERLAY_SCALING_FACTOR;
+		Pointer_String_Text++;
+	}
+}
+
+/** Draw a histogram as vertical bars scaled to the most populated bucket, with the current draw color.
+ * @param Pointer_Renderer The renderer to draw with.
+ * @param X Histogram left coordinate.
+ * @param Y Histogram bottom coordinate.
+ * @param Pointer_Histogram The histogram to draw.
+ */
+static void TelemetryOverlayDrawHistogram(SDL_Renderer *Pointer_Renderer, int X, int Y, atomic_ullong *Pointer_Histogram)
+{
+	unsigned long long Bucket_Values[TELEMETRY_HISTOGRAM_BUCKETS_COUNT], Maximum_Value = 1; // Start from 1 to avoid dividing by zero
+	int i, Height;
+	
+	// Take a snapshot of the histogram as it can be updated by other threads
+	for (i = 0; i < TELEMETRY_HISTOGRAM_BUCKETS_COUNT; i++)
+	{
+		Bucket_Values[i] = atomic_load_explicit(&Pointer_Histogram[i], memory_order_relaxed);
+		if (Bucket_Values[i] > Maximum_Value) Maximum_Value = Bucket_Values[i];
+	}
+	
+	for (i = 0; i < TELEMETRY_HISTOGRAM_BUCKETS_COUNT; i++)
+	{
+		// Always draw a one pixel bar to make empty buckets visible
+		Height = Bucket_Values[i] * TELEMETRY_OVERLAY_HISTOGRAM_HEIGHT / Maximum_Value;
+		if (Height == 0) Height = 1;
+		TelemetryOverlayFillRectangle(Pointer_Renderer, X + i * TELEMETRY_OVERLAY_HISTOGRAM_BAR_WIDTH, Y - Height, TELEMETRY_OVERLAY_HISTOGRAM_BAR_WIDTH - 1, Height);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Public functions
+//-------------------------------------------------------------------------------------------------
+int TelemetryInitialize(void)
+{
+	struct sockaddr_un Address;
+	struct stat File_Status;
+	int Refresh_Rate;
+	
+	Telemetry_Performance_Counter_Frequency = SDL_GetPerformanceFrequency();
+	Telemetry_Start_Timestamp = SDL_GetPerformanceCounter();
+	
+	// Get the refresh rate of the display the window is on, a frame lasting more than one and a half refresh period is considered as dropped
+	Refresh_Rate = DisplayGetRefreshRate();
+	if (Refresh_Rate <= 0)
+	{
+		LOG_DEBUG("Could not determine display refresh rate, assuming %d Hz.", TELEMETRY_DEFAULT_DISPLAY_REFRESH_RATE);
+		Refresh_Rate = TELEMETRY_DEFAULT_DISPLAY_REFRESH_RATE;
+	}
+	Telemetry_Dropped_Frame_Threshold = 1000000ULL * 3 / (2 * Refresh_Rate);
+	LOG_DEBUG("Display refresh rate is %d Hz, frames lasting more than %llu us will be considered as dropped.", Refresh_Rate, Telemetry_Dropped_Frame_Threshold);
+	
+	// Retrieve the publication settings
+	Pointer_String_Telemetry_Statistics_File_Name = getenv(TELEMETRY_ENVIRONMENT_VARIABLE_STATISTICS_FILE);
+	if (Pointer_String_Telemetry_Statistics_File_Name != NULL) LOG_DEBUG("Statistics will be written to '%s'.", Pointer_String_Telemetry_Statistics_File_Name);
+	Pointer_String_Telemetry_Statistics_Socket_Name = getenv(TELEMETRY_ENVIRONMENT_VARIABLE_STATISTICS_SOCKET);
+	
+	// Create the statistics socket
+	if (Pointer_String_Telemetry_Statistics_Socket_Name != NULL)
+	{
+		LOG_DEBUG("Creating statistics socket '%s'...", Pointer_String_Telemetry_Statistics_Socket_Name);
+		if (strlen(Pointer_String_Telemetry_Statistics_Socket_Name) >= sizeof(Address.sun_path))
+		{
+			LOG_ERROR("Statistics socket path '%s' is too long.", Pointer_String_Telemetry_Statistics_Socket_Name);
+			return -1;
+		}
+		memset(&Address, 0, sizeof(Address));
+		Address.sun_family = AF_UNIX;
+		strcpy(Address.sun_path, Pointer_String_Telemetry_Statistics_Socket_Name);
+		
+		Telemetry_Statistics_Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (Telemetry_Statistics_Socket == -1)
+		{
+			LOG_ERROR("Failed to create statistics socket (%s).", strerror(errno));
+			return -1;
+		}
+		
+		// Remove the socket file a previous emulator instance could have left, but never remove another kind of file
+		if (lstat(Pointer_String_Telemetry_Statistics_Socket_Name, &File_Status) == 0)
+		{
+			if (!S_ISSOCK(File_Status.st_mode))
+			{
+				LOG_ERROR("Statistics socket path '%s' is already used by a file that is not a socket.", Pointer_String_Telemetry_Statistics_Socket_Name);
+				close(Telemetry_Statistics_Socket);
+				Telemetry_Statistics_Socket = -1;
+				return -1;
+			}
+			unlink(Pointer_String_Telemetry_Statistics_Socket_Name);
+		}
+		if ((bind(Telemetry_Statistics_Socket, (struct sockaddr *) &Address, sizeof(Address)) != 0) || (listen(Telemetry_Statistics_Socket, 4) != 0))
+		{
+			LOG_ERROR("Failed to bind statistics socket to '%s' (%s).", Pointer_String_Telemetry_Statistics_Socket_Name, strerror(errno));
+			close(Telemetry_Statistics_Socket);
+			Telemetry_Statistics_Socket = -1;
+			return -1;
+		}
+	}
+	
+	// Nothing to publish, the counters are still needed by the overlay
+	if ((Pointer_String_Telemetry_Statistics_File_Name == NULL) && (Telemetry_Statistics_Socket == -1)) LOG_DEBUG("No statistics publication method is enabled.");
+	
+	if (SDL_CreateThread(TelemetryThreadPublish, "Telemetry", NULL) == NULL)
+	{
+		LOG_ERROR("Failed to create telemetry thread (%s).", SDL_GetError());
+		if (Telemetry_Statistics_Socket != -1)
+		{
+			close(Telemetry_Statistics_Socket);
+			unlink(Pointer_String_Telemetry_Statistics_Socket_Name);
+		}
+		return -1;
+	}
+	
+	return 0;
+}
+
+void TelemetryUninitialize(void)
+{
+	// The telemetry thread may still be waiting on the socket, so let the process termination close it
+	if (Telemetry_Statistics_Socket != -1) unlink(Pointer_String_Telemetry_Statistics_Socket_Name);
+}
+
+void TelemetryAddExecutedInstructions(int Count)
+{
+	atomic_fetch_add_explicit(&Telemetry_Executed_Instructions_Count, Count, memory_order_relaxed);
+	atomic_fetch_add_explicit(&Telemetry_Processor_Dispatches_Count, 1, memory_order_relaxed);
+}
+
+void TelemetryAddProcessorStallTime(Uint64 Duration)
+{
+	atomic_fetch_add_explicit(&Telemetry_Processor_Stall_Time, TelemetryConvertTicksToMicroseconds(Duration), memory_order_relaxed);
+}
+
+void TelemetryRecordFrame(Uint64 Duration)
+{
+	unsigned long long Microseconds;
+	
+	Microseconds = TelemetryConvertTicksToMicroseconds(Duration);
+	atomic_fetch_add_explicit(&Telemetry_Frames_Count, 1, memory_order_relaxed);
+	if (Microseconds > Telemetry_Dropped_Frame_Threshold) atomic_fetch_add_explicit(&Telemetry_Dropped_Frames_Count, 1, memory_order_relaxed);
+	TelemetryAddToHistogram(Telemetry_Frame_Time_Histogram, Microseconds);
+}
+
+void TelemetryRecordPresentLatency(Uint64 Duration)
+{
+	TelemetryAddToHistogram(Telemetry_Present_Latency_Histogram, TelemetryConvertTicksToMicroseconds(Duration));
+}
+
+void TelemetryToggleOverlay(void)
+{
+	Telemetry_Is_Overlay_Enabled = !Telemetry_Is_Overlay_Enabled;
+	LOG_DEBUG("Statistics overlay is %s.", Telemetry_Is_Overlay_Enabled ? "enabled" : "disabled");
+}
+
+void TelemetryDrawOverlay(SDL_Renderer *Pointer_Renderer)
+{
+	char String_Text[32];
+	int Line_Height, Y;
+	unsigned long long Instructions_Per_Second;
+	
+	if (!Telemetry_Is_Overlay_Enabled) return;
+	
+	// Darken the overlay area to make it readable whatever the Chip-8 display content is
+	if (SDL_SetRenderDrawBlendMode(Pointer_Renderer, SDL_BLENDMODE_BLEND) != 0)
+	{
+		LOG_ERROR("Could not set rendering blend mode (%s).", SDL_GetError());
+		exit(EXIT_FAILURE);
+	}
+	Line_Height = (TELEMETRY_OVERLAY_CHARACTER_HEIGHT + 1) * TELEMETRY_OVERLAY_SCALING_FACTOR;
+	TelemetryOverlaySetColor(Pointer_Renderer, 0, 0, 0, 160);
+	TelemetryOverlayFillRectangle(Pointer_Renderer, 0, 0, 3 * TELEMETRY_OVERLAY_MARGIN + 2 * TELEMETRY_HISTOGRAM_BUCKETS_COUNT * TELEMETRY_OVERLAY_HISTOGRAM_BAR_WIDTH, 3 * TELEMETRY_OVERLAY_MARGIN + 3 * Line_Height + TELEMETRY_OVERLAY_HISTOGRAM_HEIGHT);
+	
+	// Display emulation speed and dropped frames
+	TelemetryOverlaySetColor(Pointer_Renderer, 255, 255, 255, 255);
+	Instructions_Per_Second = atomic_load_explicit(&Telemetry_Instructions_Per_Second, memory_order_relaxed);
+	Y = TELEMETRY_OVERLAY_MARGIN;
+	snprintf(String_Text, sizeof(String_Text), "IPS %llu", Instructions_Per_Second);
+	TelemetryOverlayDrawText(Pointer_Renderer, TELEMETRY_OVERLAY_MARGIN, Y, String_Text);
+	Y += Line_Height;
+	snprintf(String_Text, sizeof(String_Text), "SPD %llu%%", Instructions_Per_Second * 100 / TELEMETRY_NOMINAL_INSTRUCTIONS_PER_SECOND);
+	TelemetryOverlayDrawText(Pointer_Renderer, TELEMETRY_OVERLAY_MARGIN, Y, String_Text);
+	Y += Line_Height;
+	snprintf(String_Text, sizeof(String_Text), "DROP %llu", atomic_load_explicit(&Telemetry_Dropped_Frames_Count, memory_order_relaxed));
+	TelemetryOverlayDrawText(Pointer_Renderer, TELEMETRY_OVERLAY_MARGIN, Y, String_Text);
+	Y += Line_Height + TELEMETRY_OVERLAY_MARGIN + TELEMETRY_OVERLAY_HISTOGRAM_HEIGHT;
+	
+	// Display frame time histogram in green and present latency histogram in yellow
+	TelemetryOverlaySetColor(Pointer_Renderer, 0, 255, 0, 255);
+	TelemetryOverlayDrawHistogram(Pointer_Renderer, TELEMETRY_OVERLAY_MARGIN, Y, Telemetry_Frame_Time_Histogram);
+	TelemetryOverlaySetColor(Pointer_Renderer, 255, 255, 0, 255);
+	TelemetryOverlayDrawHistogram(Pointer_Renderer, 2 * TELEMETRY_OVERLAY_MARGIN + TELEMETRY_HISTOGRAM_BUCKETS_COUNT * TELEMETRY_OVERLAY_HISTOGRAM_BAR_WIDTH, Y, Telemetry_Present_Latency_Histogram);
+}